@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/query_allocations_test.dir/search-server/tests/query_allocations_test.cpp.o"
+  "CMakeFiles/query_allocations_test.dir/search-server/tests/query_allocations_test.cpp.o.d"
+  "query_allocations_test"
+  "query_allocations_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/query_allocations_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
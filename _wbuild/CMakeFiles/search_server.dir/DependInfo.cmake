@@ -0,0 +1,30 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/search-server/document.cpp" "CMakeFiles/search_server.dir/search-server/document.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/document.cpp.o.d"
+  "/root/repo/search-server/document_attributes.cpp" "CMakeFiles/search_server.dir/search-server/document_attributes.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/document_attributes.cpp.o.d"
+  "/root/repo/search-server/positional_index.cpp" "CMakeFiles/search_server.dir/search-server/positional_index.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/positional_index.cpp.o.d"
+  "/root/repo/search-server/query_arena.cpp" "CMakeFiles/search_server.dir/search-server/query_arena.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/query_arena.cpp.o.d"
+  "/root/repo/search-server/query_trace.cpp" "CMakeFiles/search_server.dir/search-server/query_trace.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/query_trace.cpp.o.d"
+  "/root/repo/search-server/ranked_results.cpp" "CMakeFiles/search_server.dir/search-server/ranked_results.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/ranked_results.cpp.o.d"
+  "/root/repo/search-server/read_input_functions.cpp" "CMakeFiles/search_server.dir/search-server/read_input_functions.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/read_input_functions.cpp.o.d"
+  "/root/repo/search-server/request_queue.cpp" "CMakeFiles/search_server.dir/search-server/request_queue.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/request_queue.cpp.o.d"
+  "/root/repo/search-server/search_limits.cpp" "CMakeFiles/search_server.dir/search-server/search_limits.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/search_limits.cpp.o.d"
+  "/root/repo/search-server/search_server.cpp" "CMakeFiles/search_server.dir/search-server/search_server.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/search_server.cpp.o.d"
+  "/root/repo/search-server/string_processing.cpp" "CMakeFiles/search_server.dir/search-server/string_processing.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/string_processing.cpp.o.d"
+  "/root/repo/search-server/thread_pool.cpp" "CMakeFiles/search_server.dir/search-server/thread_pool.cpp.o" "gcc" "CMakeFiles/search_server.dir/search-server/thread_pool.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,33 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/search_server.dir/search-server/document.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/document.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/document_attributes.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/document_attributes.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/positional_index.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/positional_index.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/query_arena.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/query_arena.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/query_trace.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/query_trace.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/ranked_results.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/ranked_results.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/read_input_functions.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/read_input_functions.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/request_queue.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/request_queue.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/search_limits.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/search_limits.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/search_server.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/search_server.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/string_processing.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/string_processing.cpp.o.d"
+  "CMakeFiles/search_server.dir/search-server/thread_pool.cpp.o"
+  "CMakeFiles/search_server.dir/search-server/thread_pool.cpp.o.d"
+  "libsearch_server.a"
+  "libsearch_server.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/search_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,8 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_wbuild
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(query_allocations "/root/repo/_wbuild/query_allocations_test")
+set_tests_properties(query_allocations PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;30;add_test;/root/repo/CMakeLists.txt;0;")
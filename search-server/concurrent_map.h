@@ -1,5 +1,10 @@
+#pragma once
+
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -12,10 +17,45 @@ using namespace std::string_literals;
 template <typename Key, typename Value>
 class ConcurrentMap {
 private:
+    // Memory taken from the map's resource by the constructing thread
+    struct Reservation {
+        Reservation(std::pmr::memory_resource* resource, size_t bytes)
+            : resource(resource)
+            , bytes(bytes)
+            , data(resource->allocate(bytes)) {
+        }
+
+        ~Reservation() {
+            resource->deallocate(data, bytes);
+        }
+
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+        std::pmr::memory_resource* resource;
+        size_t bytes;
+        void* data;
+    };
+
+    // Each bucket allocates its nodes from its own block, so workers holding different buckets
+    // never share an allocator. Past the block, nodes come from the heap, which is thread-safe.
     struct Bucket {
+        using allocator_type = std::pmr::polymorphic_allocator<Bucket>;
+
+        Bucket(size_t reserved_bytes, const allocator_type& alloc)
+            : reservation(alloc.resource(), reserved_bytes)
+            , nodes(reservation.data, reservation.bytes, std::pmr::new_delete_resource())
+            , map(&nodes) {
+        }
+
         std::mutex mutex;
-        std::map<Key, Value> map;
+        Reservation reservation;
+        std::pmr::monotonic_buffer_resource nodes;
+        std::pmr::map<Key, Value> map;
     };
+
+    // Roughly a tree node: the value plus three pointers and a color
+    static constexpr size_t NODE_SIZE = sizeof(std::pair<const Key, Value>) + 4 * sizeof(void*);
  
 public:
     static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
@@ -30,8 +70,15 @@ public:
         }
     };
  
-    explicit ConcurrentMap(size_t bucket_count)
-        : buckets_(bucket_count) {
+    // The resource is used only by the constructing thread and by BuildOrdinaryMap.
+    // Buckets reserve room for about expected_size keys in total up front.
+    explicit ConcurrentMap(size_t bucket_count, std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                           size_t expected_size = 0)
+        : buckets_(resource) {
+        const size_t reserved_bytes = (expected_size / bucket_count + 1) * NODE_SIZE;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            buckets_.emplace_back(reserved_bytes);
+        }
     }
  
     Access operator[](const Key& key) {
@@ -39,15 +86,16 @@ public:
         return {key, bucket};
     }
  
-    std::map<Key, Value> BuildOrdinaryMap() {
-        std::map<Key, Value> result;
-        for (auto& [mutex, map] : buckets_) {
-            std::lock_guard g(mutex);
-            result.insert(map.begin(), map.end());
+    std::pmr::map<Key, Value> BuildOrdinaryMap() {
+        std::pmr::map<Key, Value> result(buckets_.get_allocator());
+        for (auto& bucket : buckets_) {
+            std::lock_guard g(bucket.mutex);
+            result.insert(bucket.map.begin(), bucket.map.end());
         }
         return result;
     }
  
 private:
-    std::vector<Bucket> buckets_;
+    // A deque, since buckets can be neither copied nor moved
+    std::pmr::deque<Bucket> buckets_;
 };
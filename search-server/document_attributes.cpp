@@ -0,0 +1,87 @@
+#include "document_attributes.h"
+
+#include <algorithm>
+
+DocumentFilter::DocumentFilter(DocumentStatus status) {
+    WithStatuses({status});
+}
+
+DocumentFilter& DocumentFilter::WithStatuses(std::initializer_list<DocumentStatus> statuses) {
+    status_mask = 0;
+    for (const DocumentStatus status : statuses) {
+        status_mask |= static_cast<uint8_t>(1u << static_cast<int>(status));
+    }
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::WithRating(int min, int max) {
+    min_rating = min;
+    max_rating = max;
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::WithIds(int min, int max) {
+    min_id = min;
+    max_id = max;
+    return *this;
+}
+
+void DocumentAttributes::Add(int document_id, DocumentStatus status, int rating) {
+    size_t slot = ids_.size();
+    if (free_slots_.empty()) {
+        // Reserve up front so that the push_backs below cannot throw halfway
+        const size_t capacity = slot < ids_.capacity() ? ids_.capacity() : std::max<size_t>(2 * slot, 1);
+        ids_.reserve(capacity);
+        ratings_.reserve(capacity);
+        status_indexes_.reserve(capacity);
+        status_bits_.reserve(capacity);
+    } else {
+        slot = free_slots_.back();
+    }
+    id_to_slot_.emplace(document_id, slot);
+
+    if (slot == ids_.size()) {
+        ids_.push_back(document_id);
+        ratings_.push_back(rating);
+        status_indexes_.push_back(static_cast<uint8_t>(status));
+        status_bits_.push_back(static_cast<uint8_t>(1u << static_cast<int>(status)));
+    } else {
+        free_slots_.pop_back();
+        ids_[slot] = document_id;
+        ratings_[slot] = rating;
+        status_indexes_[slot] = static_cast<uint8_t>(status);
+        status_bits_[slot] = static_cast<uint8_t>(1u << static_cast<int>(status));
+    }
+}
+
+void DocumentAttributes::Remove(int document_id) {
+    const auto it = id_to_slot_.find(document_id);
+    if (it == id_to_slot_.end()) {
+        return;
+    }
+    free_slots_.push_back(it->second);
+    status_bits_[it->second] = 0;
+    id_to_slot_.erase(it);
+}
+
+std::pmr::vector<uint8_t> DocumentAttributes::Select(const DocumentFilter& filter, std::pmr::memory_resource* resource) const {
+    std::pmr::vector<uint8_t> mask(ids_.size(), 0, resource);
+
+    const int* ids = ids_.data();
+    const int* ratings = ratings_.data();
+    const uint8_t* status_bits = status_bits_.data();
+    uint8_t* out = mask.data();
+    const uint8_t status_mask = filter.status_mask;
+    const int min_rating = filter.min_rating;
+    const int max_rating = filter.max_rating;
+    const int min_id = filter.min_id;
+    const int max_id = filter.max_id;
+    for (size_t i = 0; i < mask.size(); ++i) {
+        out[i] = static_cast<uint8_t>(((status_bits[i] & status_mask) != 0)
+                                      & (ratings[i] >= min_rating)
+                                      & (ratings[i] <= max_rating)
+                                      & (ids[i] >= min_id)
+                                      & (ids[i] <= max_id));
+    }
+    return mask;
+}
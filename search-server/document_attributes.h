@@ -0,0 +1,82 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+// Structured replacement for the common "status is X and rating in [a, b]" lambdas.
+// Unlike an arbitrary predicate it can be evaluated over all documents at once.
+struct DocumentFilter {
+    static const uint8_t ALL_STATUSES = 0xFF;
+
+    DocumentFilter() = default;
+    explicit DocumentFilter(DocumentStatus status);
+
+    DocumentFilter& WithStatuses(std::initializer_list<DocumentStatus> statuses);
+    DocumentFilter& WithRating(int min, int max);
+    DocumentFilter& WithIds(int min, int max);
+
+    bool operator()(int document_id, DocumentStatus status, int rating) const {
+        return (status_mask >> static_cast<int>(status) & 1) != 0
+               && rating >= min_rating && rating <= max_rating
+               && document_id >= min_id && document_id <= max_id;
+    }
+
+    uint8_t status_mask = ALL_STATUSES;
+    int min_rating = INT_MIN;
+    int max_rating = INT_MAX;
+    int min_id = 0;
+    int max_id = INT_MAX;
+};
+
+// Structure-of-arrays storage of per-document attributes, so that posting traversal does not need
+// tree lookups into documents_. Documents occupy dense slots: memory follows the number of
+// documents, not the largest id. Slots of removed documents are reused.
+class DocumentAttributes {
+public:
+    // Has no effect on failure
+    void Add(int document_id, DocumentStatus status, int rating);
+
+    void Remove(int document_id);
+
+    // The document must be present
+    size_t GetSlot(int document_id) const {
+        return id_to_slot_.at(document_id);
+    }
+
+    DocumentStatus GetStatusAt(size_t slot) const {
+        return static_cast<DocumentStatus>(status_indexes_[slot]);
+    }
+
+    int GetRatingAt(size_t slot) const {
+        return ratings_[slot];
+    }
+
+    int GetRating(int document_id) const {
+        return ratings_[GetSlot(document_id)];
+    }
+
+    // Live documents plus free slots
+    size_t GetSlotCount() const {
+        return ids_.size();
+    }
+
+    // Returns a candidate mask with one byte per slot: 1 if the slot holds a document that passes the filter.
+    // The loop is branch-free over dense arrays so the compiler can vectorize it.
+    std::pmr::vector<uint8_t> Select(const DocumentFilter& filter,
+                                     std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+private:
+    std::unordered_map<int, size_t> id_to_slot_;
+    std::vector<size_t> free_slots_;
+    std::vector<int> ids_;
+    std::vector<int> ratings_;
+    std::vector<uint8_t> status_indexes_;
+    // 1 << status for occupied slots, 0 for free ones
+    std::vector<uint8_t> status_bits_;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
 #include <iostream>
@@ -39,31 +41,75 @@ std::ostream& operator<<(std::ostream& out, const IteratorRange<Iterator>& range
     return out;
 }
 
+// Pages are not stored: each page boundary is computed when the page iterator reaches it
 template <typename Iterator>
 class Paginator {
 public:
-    Paginator(Iterator begin, Iterator end, size_t page_size) {
+    class PageIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = IteratorRange<Iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = IteratorRange<Iterator>;
 
+        PageIterator(Iterator begin, size_t left, size_t page_size)
+                : begin_(begin)
+                , left_(left)
+                , page_size_(page_size) {
+        }
+
+        IteratorRange<Iterator> operator*() const {
+            return {begin_, next(begin_, std::min(page_size_, left_))};
+        }
 
-        for (size_t left = distance(begin, end); left > 0;) {
-            const size_t current_page_size = std::min(page_size, left);
-            const Iterator current_page_end = next(begin, current_page_size);
-            pages_.push_back({begin, current_page_end});
-            left -= current_page_size;
-            begin = current_page_end;
+        PageIterator& operator++() {
+            const size_t current_page_size = std::min(page_size_, left_);
+            begin_ = next(begin_, current_page_size);
+            left_ -= current_page_size;
+            return *this;
         }
+
+        PageIterator operator++(int) {
+            PageIterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            return left_ == other.left_;
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        Iterator begin_;
+        size_t left_;
+        size_t page_size_;
+    };
+
+    Paginator(Iterator begin, Iterator end, size_t page_size)
+            : begin_(begin)
+            , end_(end)
+            , count_(distance(begin, end))
+            , page_size_(page_size) {
     }
-    auto begin() const {
-        return pages_.begin();
+    PageIterator begin() const {
+        return {begin_, page_size_ == 0 ? 0 : count_, page_size_};
     }
-    auto end() const {
-        return pages_.end();
+    PageIterator end() const {
+        return {end_, 0, page_size_};
     }
     size_t size() const {
-        return pages_.size();
+        return page_size_ == 0 ? 0 : (count_ + page_size_ - 1) / page_size_;
     }
 private:
-    std::vector<IteratorRange<Iterator>> pages_;
+    Iterator begin_;
+    Iterator end_;
+    size_t count_;
+    size_t page_size_;
 };
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
@@ -0,0 +1,272 @@
+#include "positional_index.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace {
+
+void EncodeVarint(uint32_t value, std::vector<uint8_t>& out) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+}  // namespace
+
+void PositionalIndex::AddDocument(int document_id, const std::vector<std::string_view>& words,
+                                  const std::vector<uint32_t>& positions) {
+    std::map<std::string_view, std::vector<uint32_t>> word_positions;
+    for (size_t i = 0; i < words.size(); ++i) {
+        word_positions[words[i]].push_back(positions[i]);
+    }
+    for (const auto& [word, positions] : word_positions) {
+        auto it = word_to_postings_.find(word);
+        if (it == word_to_postings_.end()) {
+            it = word_to_postings_.emplace(std::string(word), PostingList()).first;
+        }
+        PostingList& list = it->second;
+
+        const uint32_t offset = static_cast<uint32_t>(list.positions.size());
+        uint32_t previous = 0;
+        for (const uint32_t position : positions) {
+            EncodeVarint(position - previous, list.positions);
+            previous = position;
+        }
+        const Posting posting{document_id, offset, static_cast<uint32_t>(list.positions.size()) - offset};
+
+        // Ids usually grow, so this is an append
+        auto posting_it = std::lower_bound(list.postings.begin(), list.postings.end(), document_id,
+                                           [](const Posting& lhs, int id) { return lhs.document_id < id; });
+        list.postings.insert(posting_it, posting);
+    }
+}
+
+void PositionalIndex::RemoveDocument(int document_id, const std::vector<std::string_view>& words) {
+    for (const std::string_view word : words) {
+        auto it = word_to_postings_.find(word);
+        if (it == word_to_postings_.end()) {
+            continue;
+        }
+        PostingList& list = it->second;
+        const size_t index = Seek(list.postings, 0, document_id);
+        if (index == list.postings.size() || list.postings[index].document_id != document_id) {
+            continue;
+        }
+        list.garbage += list.postings[index].size;
+        list.postings.erase(list.postings.begin() + index);
+        if (list.postings.empty()) {
+            word_to_postings_.erase(it);
+        } else if (list.garbage * 2 > list.positions.size()) {
+            Compact(list);
+        }
+    }
+}
+
+bool PositionalIndex::ContainsPhrase(int document_id, const std::pmr::vector<std::string_view>& phrase,
+                                     std::pmr::memory_resource* resource) const {
+    if (phrase.empty()) {
+        return true;
+    }
+    // Called once per candidate document: scratch memory goes back to the stack on return
+    // instead of piling up in the caller's resource
+    std::array<std::byte, 1024> buffer;
+    std::pmr::monotonic_buffer_resource scratch(buffer.data(), buffer.size(), resource);
+    std::pmr::vector<std::pmr::vector<uint32_t>> positions(phrase.size(), &scratch);
+    size_t lead = 0;
+    for (size_t i = 0; i < phrase.size(); ++i) {
+        if (phrase[i].empty()) {
+            continue;
+        }
+        const auto it = word_to_postings_.find(phrase[i]);
+        if (it == word_to_postings_.end()) {
+            return false;
+        }
+        const auto& postings = it->second.postings;
+        const size_t index = Seek(postings, 0, document_id);
+        if (index == postings.size() || postings[index].document_id != document_id) {
+            return false;
+        }
+        DecodePositions(it->second, postings[index], positions[i]);
+        if (phrase[lead].empty() || positions[i].size() < positions[lead].size()) {
+            lead = i;
+        }
+    }
+    return IsConsecutive(phrase, positions, lead);
+}
+
+std::pmr::vector<int> PositionalIndex::FindPhrase(const std::pmr::vector<std::string_view>& phrase,
+                                                  std::pmr::memory_resource* resource) const {
+    std::pmr::vector<int> result(resource);
+    if (phrase.empty()) {
+        return result;
+    }
+    // Stop word places have no list and take no part in the intersection
+    std::pmr::vector<const PostingList*> lists(phrase.size(), nullptr, resource);
+    std::pmr::vector<size_t> order(resource);
+    for (size_t i = 0; i < phrase.size(); ++i) {
+        if (phrase[i].empty()) {
+            continue;
+        }
+        const auto it = word_to_postings_.find(phrase[i]);
+        if (it == word_to_postings_.end()) {
+            return result;
+        }
+        lists[i] = &it->second;
+        order.push_back(i);
+    }
+    if (order.empty()) {
+        return result;
+    }
+
+    // Drive the intersection by the rarest word
+    std::sort(order.begin(), order.end(), [&lists](size_t lhs, size_t rhs) {
+        return lists[lhs]->postings.size() < lists[rhs]->postings.size();
+    });
+    std::pmr::vector<size_t> cursors(phrase.size(), 0, resource);
+    std::pmr::vector<std::pmr::vector<uint32_t>> positions(phrase.size(), resource);
+
+    const PostingList& lead = *lists[order[0]];
+    for (const Posting& lead_posting : lead.postings) {
+        const int document_id = lead_posting.document_id;
+        bool all_contain = true;
+        for (size_t i = 1; i < order.size(); ++i) {
+            const auto& postings = lists[order[i]]->postings;
+            size_t& cursor = cursors[order[i]];
+            cursor = Seek(postings, cursor, document_id);
+            if (cursor == postings.size()) {
+                return result;
+            }
+            if (postings[cursor].document_id != document_id) {
+                all_contain = false;
+                break;
+            }
+        }
+        if (!all_contain) {
+            continue;
+        }
+
+        DecodePositions(lead, lead_posting, positions[order[0]]);
+        for (size_t i = 1; i < order.size(); ++i) {
+            DecodePositions(*lists[order[i]], lists[order[i]]->postings[cursors[order[i]]], positions[order[i]]);
+        }
+        if (IsConsecutive(phrase, positions, order[0])) {
+            result.push_back(document_id);
+        }
+    }
+    return result;
+}
+
+std::pmr::vector<uint32_t> PositionalIndex::ComputeMinimalGaps(const std::pmr::vector<std::string_view>& words,
+                                                               const std::pmr::vector<int>& document_ids,
+                                                               std::pmr::memory_resource* resource) const {
+    std::pmr::vector<uint32_t> gaps(document_ids.size(), 0, resource);
+    std::pmr::vector<const PostingList*> lists(resource);
+    for (const std::string_view word : words) {
+        const auto it = word_to_postings_.find(word);
+        if (it != word_to_postings_.end()) {
+            lists.push_back(&it->second);
+        }
+    }
+    if (lists.size() < 2) {
+        return gaps;
+    }
+
+    std::pmr::vector<size_t> cursors(lists.size(), 0, resource);
+    // (position, index of the word)
+    std::pmr::vector<std::pair<uint32_t, size_t>> occurrences(resource);
+    std::pmr::vector<uint32_t> positions(resource);
+    for (size_t d = 0; d < document_ids.size(); ++d) {
+        const int document_id = document_ids[d];
+        occurrences.clear();
+        size_t words_found = 0;
+        for (size_t i = 0; i < lists.size(); ++i) {
+            const auto& postings = lists[i]->postings;
+            cursors[i] = Seek(postings, cursors[i], document_id);
+            if (cursors[i] == postings.size() || postings[cursors[i]].document_id != document_id) {
+                continue;
+            }
+            ++words_found;
+            DecodePositions(*lists[i], postings[cursors[i]], positions);
+            for (const uint32_t position : positions) {
+                occurrences.push_back({position, i});
+            }
+        }
+        if (words_found < 2) {
+            continue;
+        }
+        std::sort(occurrences.begin(), occurrences.end());
+        uint32_t minimal_gap = UINT32_MAX;
+        for (size_t i = 1; i < occurrences.size(); ++i) {
+            if (occurrences[i].second != occurrences[i - 1].second) {
+                minimal_gap = std::min(minimal_gap, occurrences[i].first - occurrences[i - 1].first);
+            }
+        }
+        gaps[d] = minimal_gap;
+    }
+    return gaps;
+}
+
+size_t PositionalIndex::Seek(const std::vector<Posting>& postings, size_t from, int document_id) {
+    // Gallop to bracket the target, then binary search inside the bracket
+    size_t step = 1;
+    size_t low = from;
+    while (low + step < postings.size() && postings[low + step].document_id < document_id) {
+        low += step;
+        step *= 2;
+    }
+    const size_t high = std::min(postings.size(), low + step + 1);
+    return std::lower_bound(postings.begin() + low, postings.begin() + high, document_id,
+                            [](const Posting& lhs, int id) { return lhs.document_id < id; })
+           - postings.begin();
+}
+
+void PositionalIndex::DecodePositions(const PostingList& list, const Posting& posting, std::pmr::vector<uint32_t>& positions) {
+    positions.clear();
+    const uint8_t* data = list.positions.data() + posting.offset;
+    const uint8_t* end = data + posting.size;
+    uint32_t position = 0;
+    while (data != end) {
+        uint32_t delta = 0;
+        int shift = 0;
+        while (*data & 0x80) {
+            delta |= static_cast<uint32_t>(*data++ & 0x7F) << shift;
+            shift += 7;
+        }
+        delta |= static_cast<uint32_t>(*data++) << shift;
+        position += delta;
+        positions.push_back(position);
+    }
+}
+
+void PositionalIndex::Compact(PostingList& list) {
+    std::vector<uint8_t> positions;
+    positions.reserve(list.positions.size() - list.garbage);
+    for (Posting& posting : list.postings) {
+        const auto begin = list.positions.begin() + posting.offset;
+        posting.offset = static_cast<uint32_t>(positions.size());
+        positions.insert(positions.end(), begin, begin + posting.size);
+    }
+    list.positions = std::move(positions);
+    list.garbage = 0;
+}
+
+bool PositionalIndex::IsConsecutive(const std::pmr::vector<std::string_view>& phrase,
+                                    const std::pmr::vector<std::pmr::vector<uint32_t>>& positions, size_t lead) {
+    const auto& lead_positions = positions[lead];
+    return std::any_of(lead_positions.begin(), lead_positions.end(), [&](uint32_t lead_position) {
+        if (lead_position < lead) {
+            return false;
+        }
+        const uint32_t start = lead_position - static_cast<uint32_t>(lead);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (i != lead && !phrase[i].empty() && !std::binary_search(positions[i].begin(), positions[i].end(), start + static_cast<uint32_t>(i))) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Word positions per document, used for phrase matching and proximity ranking.
+// Positions count every word from the start of the document, stop words included, though stop
+// words themselves are not indexed. Each posting keeps
+// its positions as varint-encoded deltas in the word's shared byte buffer.
+class PositionalIndex {
+public:
+    // positions[i] is the position of words[i]
+    void AddDocument(int document_id, const std::vector<std::string_view>& words, const std::vector<uint32_t>& positions);
+
+    // words must be the distinct words of the document
+    void RemoveDocument(int document_id, const std::vector<std::string_view>& words);
+
+    // In a phrase, an empty word holds the place of a stop word: any word may stand there.
+
+    // Returns ids, in ascending order, of documents where the words occur consecutively.
+    // Postings are intersected starting from the rarest word, galloping through the longer lists.
+    std::pmr::vector<int> FindPhrase(const std::pmr::vector<std::string_view>& phrase,
+                                     std::pmr::memory_resource* resource) const;
+
+    // Whether the words occur consecutively in the given document
+    bool ContainsPhrase(int document_id, const std::pmr::vector<std::string_view>& phrase,
+                        std::pmr::memory_resource* resource) const;
+
+    // For each document, the smallest distance between positions of two different words from the list,
+    // or 0 if fewer than two of them occur in it. document_ids must be ascending.
+    std::pmr::vector<uint32_t> ComputeMinimalGaps(const std::pmr::vector<std::string_view>& words,
+                                                  const std::pmr::vector<int>& document_ids,
+                                                  std::pmr::memory_resource* resource) const;
+
+private:
+    struct Posting {
+        int document_id;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct PostingList {
+        std::vector<Posting> postings;
+        std::vector<uint8_t> positions;
+        // Bytes of removed postings still occupying positions
+        size_t garbage = 0;
+    };
+
+    std::map<std::string, PostingList, std::less<>> word_to_postings_;
+
+    static size_t Seek(const std::vector<Posting>& postings, size_t from, int document_id);
+
+    static void DecodePositions(const PostingList& list, const Posting& posting, std::pmr::vector<uint32_t>& positions);
+
+    // Whether some position p of positions[lead] has p - lead + i in positions[i] for every non-empty phrase[i]
+    static bool IsConsecutive(const std::pmr::vector<std::string_view>& phrase,
+                              const std::pmr::vector<std::pmr::vector<uint32_t>>& positions, size_t lead);
+
+    static void Compact(PostingList& list);
+};
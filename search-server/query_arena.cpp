@@ -0,0 +1,67 @@
+#include "query_arena.h"
+
+#include <algorithm>
+#include <memory>
+
+QueryArena::Scope::Scope()
+        : arena_(QueryArena::ForThisThread()) {
+    ++arena_.depth_;
+}
+
+QueryArena::Scope::~Scope() {
+    if (--arena_.depth_ == 0) {
+        arena_.Reset();
+    }
+}
+
+QueryArena::QueryArena()
+        : buffer_(INITIAL_SIZE) {
+}
+
+QueryArena& QueryArena::ForThisThread() {
+    thread_local QueryArena arena;
+    return arena;
+}
+
+void* QueryArena::do_allocate(size_t bytes, size_t alignment) {
+    void* ptr = buffer_.data() + offset_;
+    size_t space = buffer_.size() - offset_;
+    if (std::align(alignment, bytes, ptr, space)) {
+        offset_ = buffer_.size() - space + bytes;
+        return ptr;
+    }
+    overflow_bytes_ += bytes + alignment;
+    return overflow_.allocate(bytes, alignment);
+}
+
+void QueryArena::do_deallocate(void*, size_t, size_t) {
+    // Memory is reclaimed all at once in Reset
+}
+
+bool QueryArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void QueryArena::Reset() {
+    const size_t used = offset_ + overflow_bytes_;
+    offset_ = 0;
+    overflow_bytes_ = 0;
+    overflow_.release();
+
+    size_t new_size = buffer_.size();
+    if (used > buffer_.size()) {
+        new_size = std::min(MAX_SIZE, 2 * used);
+        underused_queries_ = 0;
+    } else if (buffer_.size() > INITIAL_SIZE && used * 4 < buffer_.size()) {
+        if (++underused_queries_ >= SHRINK_AFTER_QUERIES) {
+            new_size = std::max(INITIAL_SIZE, buffer_.size() / 2);
+            underused_queries_ = 0;
+        }
+    } else {
+        underused_queries_ = 0;
+    }
+    if (new_size != buffer_.size()) {
+        // A fresh vector, since shrinking a vector in place keeps its capacity
+        std::vector<std::byte>(new_size).swap(buffer_);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Per-thread scratch memory for FindTopDocuments. Everything a query allocates is bumped out
+// of one buffer that is rewound when the outermost Scope on the thread ends. If a query does not
+// fit, the overflow is served from the heap once and the buffer grows before the next query,
+// so steady-state queries do not touch the global allocator. The buffer never grows past
+// MAX_SIZE, and it shrinks again once queries stop needing it.
+// The arena is not synchronized: only its own thread allocates from it. Workers of a parallel
+// query get their memory from ConcurrentMap buckets, which take their blocks up front.
+class QueryArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t INITIAL_SIZE = 64 * 1024;
+    static constexpr size_t MAX_SIZE = 4 * 1024 * 1024;
+    // The buffer is halved after this many queries in a row using less than a quarter of it
+    static constexpr int SHRINK_AFTER_QUERIES = 256;
+
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        std::pmr::memory_resource* Resource() const {
+            return &arena_;
+        }
+
+    private:
+        QueryArena& arena_;
+    };
+
+    QueryArena();
+
+    static QueryArena& ForThisThread();
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void Reset();
+
+    std::vector<std::byte> buffer_;
+    size_t offset_ = 0;
+    size_t overflow_bytes_ = 0;
+    int underused_queries_ = 0;
+    std::pmr::monotonic_buffer_resource overflow_;
+    // Queries may nest when a thread steals work while waiting inside a parallel algorithm
+    int depth_ = 0;
+};
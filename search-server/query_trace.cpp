@@ -0,0 +1,175 @@
+#include "query_trace.h"
+
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::string_literals;
+
+namespace {
+
+void PrintJsonString(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (const char c : text) {
+        switch (c) {
+            case '"':
+                out << "\\\""s;
+                break;
+            case '\\':
+                out << "\\\\"s;
+                break;
+            default:
+                if (c >= '\0' && c < ' ') {
+                    const char* hex = "0123456789abcdef";
+                    out << "\\u00"s << hex[c >> 4] << hex[c & 0xF];
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+double ToMicroseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+}  // namespace
+
+const char* GetQueryStageName(QueryStage stage) {
+    switch (stage) {
+        case QueryStage::PARSE:
+            return "parse";
+        case QueryStage::SELECT_CANDIDATES:
+            return "select_candidates";
+        case QueryStage::TRAVERSE:
+            return "traverse";
+        case QueryStage::BUILD_MAP:
+            return "build_map";
+        case QueryStage::MINUS_WORDS:
+            return "minus_words";
+        case QueryStage::MERGE:
+            return "merge";
+        case QueryStage::POSITIONS:
+            return "positions";
+        case QueryStage::SORT:
+            return "sort";
+    }
+    return "unknown";
+}
+
+QueryTrace::QueryTrace(std::string_view raw_query) {
+    record_.query = std::string(raw_query);
+    record_.thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    record_.start = std::chrono::steady_clock::now();
+}
+
+void QueryTrace::Stage(QueryStage stage) {
+    const auto now = std::chrono::steady_clock::now();
+    if (current_stage_ >= 0) {
+        record_.stage_durations[current_stage_] = now - stage_start_;
+    }
+    current_stage_ = static_cast<int>(stage);
+    record_.stage_starts[current_stage_] = now - record_.start;
+    stage_start_ = now;
+}
+
+void QueryTrace::Count(size_t postings_visited, size_t documents_scored, size_t postings_filtered) {
+    postings_visited_.fetch_add(postings_visited, std::memory_order_relaxed);
+    documents_scored_.fetch_add(documents_scored, std::memory_order_relaxed);
+    postings_filtered_.fetch_add(postings_filtered, std::memory_order_relaxed);
+}
+
+QueryTraceRecord QueryTrace::Finish() {
+    if (current_stage_ >= 0) {
+        record_.stage_durations[current_stage_] = std::chrono::steady_clock::now() - stage_start_;
+        current_stage_ = -1;
+    }
+    record_.postings_visited = postings_visited_.load();
+    record_.documents_scored = documents_scored_.load();
+    record_.postings_filtered = postings_filtered_.load();
+    return record_;
+}
+
+QueryTracer::QueryTracer(size_t sample_period)
+        : sample_period_(sample_period)
+        , created_(std::chrono::steady_clock::now()) {
+    if (sample_period == 0) {
+        throw std::invalid_argument("Sample period must be positive"s);
+    }
+}
+
+bool QueryTracer::ShouldSample() {
+    return query_count_.fetch_add(1, std::memory_order_relaxed) % sample_period_ == 0;
+}
+
+void QueryTracer::Record(QueryTraceRecord record) {
+    std::lock_guard guard(mutex_);
+    records_.push_back(std::move(record));
+}
+
+std::vector<QueryTraceRecord> QueryTracer::GetRecords() const {
+    std::lock_guard guard(mutex_);
+    return records_;
+}
+
+void QueryTracer::Clear() {
+    std::lock_guard guard(mutex_);
+    records_.clear();
+}
+
+void QueryTracer::PrintJson(std::ostream& out) const {
+    std::lock_guard guard(mutex_);
+    out << '[';
+    bool first_record = true;
+    for (const auto& record : records_) {
+        if (!first_record) {
+            out << ',';
+        }
+        first_record = false;
+        out << "{\"query\":"s;
+        PrintJsonString(out, record.query);
+        out << ",\"start_us\":"s << ToMicroseconds(record.start - created_)
+            << ",\"postings_visited\":"s << record.postings_visited
+            << ",\"documents_scored\":"s << record.documents_scored
+            << ",\"postings_filtered\":"s << record.postings_filtered
+            << ",\"stages_us\":{"s;
+        for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+            if (i > 0) {
+                out << ',';
+            }
+            out << '"' << GetQueryStageName(static_cast<QueryStage>(i)) << "\":"s
+                << ToMicroseconds(record.stage_durations[i]);
+        }
+        out << "}}"s;
+    }
+    out << ']';
+}
+
+void QueryTracer::PrintChromeTrace(std::ostream& out) const {
+    std::lock_guard guard(mutex_);
+    out << "{\"traceEvents\":["s;
+    bool first_event = true;
+    for (const auto& record : records_) {
+        const double start = ToMicroseconds(record.start - created_);
+        for (size_t i = 0; i < QUERY_STAGE_COUNT; ++i) {
+            if (record.stage_durations[i].count() == 0) {
+                continue;
+            }
+            if (!first_event) {
+                out << ',';
+            }
+            first_event = false;
+            out << "{\"name\":\""s << GetQueryStageName(static_cast<QueryStage>(i))
+                << "\",\"cat\":\"query\",\"ph\":\"X\",\"pid\":0,\"tid\":"s << record.thread_hash % 1000000
+                << ",\"ts\":"s << start + ToMicroseconds(record.stage_starts[i])
+                << ",\"dur\":"s << ToMicroseconds(record.stage_durations[i])
+                << ",\"args\":{\"query\":"s;
+            PrintJsonString(out, record.query);
+            out << ",\"postings_visited\":"s << record.postings_visited
+                << ",\"documents_scored\":"s << record.documents_scored
+                << ",\"postings_filtered\":"s << record.postings_filtered << "}}"s;
+        }
+    }
+    out << "]}"s;
+}
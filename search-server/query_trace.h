@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Each stage is entered at most once per query, so every stage is one contiguous span
+enum class QueryStage {
+    PARSE,
+    SELECT_CANDIDATES,
+    TRAVERSE,
+    BUILD_MAP,
+    MINUS_WORDS,
+    MERGE,
+    POSITIONS,
+    SORT,
+};
+
+const size_t QUERY_STAGE_COUNT = 8;
+
+const char* GetQueryStageName(QueryStage stage);
+
+struct QueryTraceRecord {
+    std::string query;
+    std::chrono::steady_clock::time_point start;
+    size_t thread_hash = 0;
+    // Offsets from start; a stage that did not run has zero duration
+    std::array<std::chrono::nanoseconds, QUERY_STAGE_COUNT> stage_starts{};
+    std::array<std::chrono::nanoseconds, QUERY_STAGE_COUNT> stage_durations{};
+    size_t postings_visited = 0;
+    // Distinct documents that passed the predicate for some plus word
+    size_t documents_scored = 0;
+    // Plus word postings rejected by the predicate; a document counts once per word it contains
+    size_t postings_filtered = 0;
+};
+
+// Trace types are template arguments of the query pipeline. With NoQueryTrace every hook is an
+// empty inline call or sits behind if constexpr (Trace::enabled), so untraced queries pay nothing.
+struct NoQueryTrace {
+    static constexpr bool enabled = false;
+
+    void Stage(QueryStage) {
+    }
+
+    void Count(size_t, size_t, size_t) {
+    }
+};
+
+class QueryTrace {
+public:
+    static constexpr bool enabled = true;
+
+    explicit QueryTrace(std::string_view raw_query);
+
+    // Ends the running stage, if any, and starts the given one, which must not have run yet.
+    // Called from the query's own thread.
+    void Stage(QueryStage stage);
+
+    // May be called concurrently by workers of a parallel query
+    void Count(size_t postings_visited, size_t documents_scored, size_t postings_filtered);
+
+    QueryTraceRecord Finish();
+
+private:
+    QueryTraceRecord record_;
+    int current_stage_ = -1;
+    std::chrono::steady_clock::time_point stage_start_;
+    std::atomic<size_t> postings_visited_{0};
+    std::atomic<size_t> documents_scored_{0};
+    std::atomic<size_t> postings_filtered_{0};
+};
+
+// Collects traces of every sample_period-th query passed to it
+class QueryTracer {
+public:
+    explicit QueryTracer(size_t sample_period = 1);
+
+    bool ShouldSample();
+
+    void Record(QueryTraceRecord record);
+
+    std::vector<QueryTraceRecord> GetRecords() const;
+
+    void Clear();
+
+    void PrintJson(std::ostream& out) const;
+
+    // Chrome trace event format, loadable in chrome://tracing or Perfetto
+    void PrintChromeTrace(std::ostream& out) const;
+
+private:
+    const size_t sample_period_;
+    const std::chrono::steady_clock::time_point created_;
+    std::atomic<size_t> query_count_{0};
+    mutable std::mutex mutex_;
+    std::vector<QueryTraceRecord> records_;
+};
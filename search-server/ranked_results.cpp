@@ -0,0 +1,43 @@
+#include "ranked_results.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool IsRankedHigher(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < E) {
+        return lhs.rating > rhs.rating;
+    } else {
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
+namespace {
+
+bool IsRankedLower(const Document& lhs, const Document& rhs) {
+    return IsRankedHigher(rhs, lhs);
+}
+
+}  // namespace
+
+RankedResults::RankedResults(std::vector<Document> documents)
+        : documents_(std::move(documents)) {
+    std::make_heap(documents_.rbegin(), documents_.rend(), IsRankedLower);
+}
+
+IteratorRange<RankedResults::Iterator> RankedResults::NextPage(size_t page_size) {
+    const size_t page_end = std::min(documents_.size(), position_ + page_size);
+    for (; sorted_ < page_end; ++sorted_) {
+        std::pop_heap(documents_.rbegin(), documents_.rend() - sorted_, IsRankedLower);
+    }
+    const auto page_begin = documents_.cbegin() + position_;
+    position_ = page_end;
+    return {page_begin, documents_.cbegin() + page_end};
+}
+
+bool RankedResults::HasMore() const {
+    return position_ < documents_.size();
+}
+
+size_t RankedResults::size() const {
+    return documents_.size();
+}
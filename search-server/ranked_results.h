@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "document.h"
+#include "paginator.h"
+
+const double E = 1e-6;
+
+// Ranking order of search results: by relevance, ties broken by rating
+bool IsRankedHigher(const Document& lhs, const Document& rhs);
+
+// Cursor over the full ranked result set of one query. Scores are computed once by the server;
+// the cursor heapifies them once and pops documents only as far as the pages requested so far,
+// so reading k documents out of N costs O(N + k log N).
+class RankedResults {
+public:
+    using Iterator = std::vector<Document>::const_iterator;
+
+    explicit RankedResults(std::vector<Document> documents);
+
+    // Returns the next page_size documents in ranking order, an empty range when exhausted
+    IteratorRange<Iterator> NextPage(size_t page_size);
+
+    bool HasMore() const;
+
+    size_t size() const;
+
+private:
+    std::vector<Document> documents_;
+    size_t position_ = 0;
+    // documents_[0, sorted_) are in final order and rank higher than everything after them.
+    // documents_[sorted_, end) is a heap laid out backwards, its top at documents_.back(),
+    // so each pop lands at documents_[sorted_].
+    size_t sorted_ = 0;
+};
@@ -0,0 +1,21 @@
+#include "search_limits.h"
+
+SearchLimits& SearchLimits::WithDeadline(std::chrono::steady_clock::time_point time) {
+    deadline = time;
+    return *this;
+}
+
+SearchLimits& SearchLimits::WithTimeout(std::chrono::steady_clock::duration timeout) {
+    deadline = std::chrono::steady_clock::now() + timeout;
+    return *this;
+}
+
+SearchLimits& SearchLimits::WithMaxPostings(size_t postings) {
+    max_postings = postings;
+    return *this;
+}
+
+SearchLimits& SearchLimits::WithCancellation(std::shared_ptr<const std::atomic<bool>> flag) {
+    cancelled = std::move(flag);
+    return *this;
+}
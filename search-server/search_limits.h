@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "document.h"
+
+// Bounds on the work of a single query. Whichever limit is hit first stops it.
+struct SearchLimits {
+    SearchLimits& WithDeadline(std::chrono::steady_clock::time_point time);
+    SearchLimits& WithTimeout(std::chrono::steady_clock::duration timeout);
+    SearchLimits& WithMaxPostings(size_t postings);
+    // The caller stores true to cancel the query
+    SearchLimits& WithCancellation(std::shared_ptr<const std::atomic<bool>> flag);
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    size_t max_postings = std::numeric_limits<size_t>::max();
+    std::shared_ptr<const std::atomic<bool>> cancelled;
+};
+
+struct LimitedSearchResult {
+    std::vector<Document> documents;
+    // True when a limit stopped the query before all postings were visited
+    bool is_partial = false;
+    size_t postings_visited = 0;
+};
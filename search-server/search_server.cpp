@@ -11,33 +11,90 @@ SearchServer::SearchServer(const std::string_view stop_words_text)
 {
 }
 
+void SearchServer::EnablePositionalIndex() {
+    if (!documents_.empty()) {
+        throw std::logic_error("Positional index must be enabled before adding documents"s);
+    }
+    positional_index_enabled_ = true;
+}
+
+void SearchServer::EnableImpactOrderedIndex() {
+    if (!documents_.empty()) {
+        throw std::logic_error("Impact-ordered index must be enabled before adding documents"s);
+    }
+    impact_ordered_index_enabled_ = true;
+}
+
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
     const auto words = SplitIntoWordsNoStop(document);
+    const int rating = ComputeAverageRating(ratings);
+    // First, so that a failure here leaves the other indexes untouched
+    attributes_.Add(document_id, status, rating);
+    const size_t slot = attributes_.GetSlot(document_id);
 
     const double inv_word_count = 1.0 / words.size();
-    std::unordered_set<std::string> words_values;
     for (const std::string_view word : words) {
-        auto it = words_values.emplace(std::string(word));
-        std::string_view word_view = *it.first;
-        word_to_document_freqs_[word_view][document_id] += inv_word_count;
+        auto it = words_.find(word);
+        if (it == words_.end()) {
+            it = words_.emplace(word).first;
+        }
+        const std::string_view word_view = *it;
+        Posting& posting = word_to_document_freqs_[word_view][document_id];
+        posting.term_freq += inv_word_count;
+        posting.slot = slot;
         document_to_word_freqs_[document_id][word_view] += inv_word_count;
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, std::move(words_values) });
+    if (impact_ordered_index_enabled_) {
+        for (const auto [word, term_freq] : document_to_word_freqs_[document_id]) {
+            word_to_impact_ordered_docs_[word].insert({term_freq, document_id});
+        }
+    }
+    documents_.emplace(document_id, DocumentData{rating, status});
+    if (positional_index_enabled_) {
+        positional_index_.AddDocument(document_id, words, ComputeWordPositions(document));
+    }
     document_ids_.insert(document_id);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentFilter(status));
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter) const {
+    return FindTopDocuments(std::execution::seq, raw_query, filter);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query) const {
     return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, QueryTracer& tracer) const {
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL, tracer);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status, QueryTracer& tracer) const {
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentFilter(status), tracer);
+}
+RankedResults SearchServer::FindRankedDocuments(const std::string_view raw_query) const {
+    return FindRankedDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+RankedResults SearchServer::FindRankedDocuments(const std::string_view raw_query, DocumentStatus status) const {
+    return FindRankedDocuments(raw_query, DocumentFilter(status));
+}
+
+RankedResults SearchServer::FindRankedDocuments(const std::string_view raw_query, const DocumentFilter& filter) const {
+    return FindRankedDocuments(std::execution::seq, raw_query, filter);
+}
+
+std::future<LimitedSearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, SearchLimits limits,
+                                                                     ThreadPool& pool) const {
+    return FindTopDocumentsAsync(std::move(raw_query), DocumentFilter(DocumentStatus::ACTUAL), std::move(limits), pool);
+}
+
 int SearchServer::GetDocumentCount() const {
     return documents_.size();
 }
@@ -53,6 +110,9 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
             return { std::vector<std::string_view>(), documents_.at(document_id).status };
         }
     }
+    if (!ContainsPhrases(query, document_id)) {
+        return { std::vector<std::string_view>(), documents_.at(document_id).status };
+    }
     std::vector<std::string_view> matched_words;
     matched_words.reserve(query.plus_words.size());
     for_each(query.plus_words.begin(), query.plus_words.end(),
@@ -71,6 +131,9 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
             return { std::vector<std::string_view>(), documents_.at(document_id).status };
         }
     }
+    if (!ContainsPhrases(query, document_id)) {
+        return { std::vector<std::string_view>(), documents_.at(document_id).status };
+    }
     std::vector<std::string_view> matched_words;
     matched_words.reserve(query.plus_words.size());
 
@@ -134,6 +197,18 @@ std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_vie
     return words;
 }
 
+std::vector<uint32_t> SearchServer::ComputeWordPositions(std::string_view text) const {
+    std::vector<uint32_t> positions;
+    uint32_t position = 0;
+    for (const auto word : SplitIntoWords(text)) {
+        if (!IsStopWord(word)) {
+            positions.push_back(position);
+        }
+        ++position;
+    }
+    return positions;
+}
+
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     if (ratings.empty()) {
         return 0;
@@ -154,30 +229,159 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
     if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
         throw std::invalid_argument("Query word is invalid");
     }
-    return {text, is_minus, IsStopWord(text)};
+    return {text, is_minus, IsStopWord(text), text.find('*') != text.npos};
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text, bool sort ) const {
-    Query result;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            } else {
-                result.plus_words.push_back(query_word.data);
+SearchServer::Query SearchServer::ParseQuery(const std::string_view text, bool sort, std::pmr::memory_resource* resource) const {
+    Query result(resource);
+    bool in_phrase = false;
+    for (std::string_view word : SplitIntoWords(text, resource)) {
+        bool has_quotes = false;
+        bool phrase_ends = false;
+        if (!in_phrase && !word.empty() && word.front() == '"') {
+            in_phrase = true;
+            has_quotes = true;
+            result.phrases.emplace_back();
+            word.remove_prefix(1);
+        }
+        if (in_phrase && !word.empty() && word.back() == '"') {
+            phrase_ends = true;
+            has_quotes = true;
+            word.remove_suffix(1);
+        }
+        if (word.find('"') != word.npos) {
+            throw std::invalid_argument("Misplaced quotes in query"s);
+        }
+        if (!(has_quotes && word.empty())) {
+            const auto query_word = ParseQueryWord(word);
+            if (in_phrase && query_word.is_minus) {
+                throw std::invalid_argument("Minus word inside quotes"s);
             }
+            if (query_word.is_wildcard) {
+                if (in_phrase) {
+                    throw std::invalid_argument("Wildcard inside quotes"s);
+                }
+                ExpandWildcard(query_word.data, query_word.is_minus ? result.minus_words : result.plus_words);
+            } else if (!query_word.is_stop) {
+                if (query_word.is_minus) {
+                    result.minus_words.push_back(query_word.data);
+                } else {
+                    result.plus_words.push_back(query_word.data);
+                    result.literal_plus_words.push_back(query_word.data);
+                }
+                if (in_phrase) {
+                    result.phrases.back().push_back(query_word.data);
+                }
+            } else if (in_phrase) {
+                result.phrases.back().emplace_back();
+            }
+        }
+        if (phrase_ends) {
+            in_phrase = false;
+        }
+    }
+    if (in_phrase) {
+        throw std::invalid_argument("Unterminated quotes in query"s);
+    }
+    // Stop words at the edges of a phrase do not constrain it; a single quoted word is an ordinary plus word
+    for (auto& phrase : result.phrases) {
+        while (!phrase.empty() && phrase.back().empty()) {
+            phrase.pop_back();
         }
+        phrase.erase(phrase.begin(), std::find_if(phrase.begin(), phrase.end(),
+                                                  [](std::string_view word) { return !word.empty(); }));
     }
+    result.phrases.erase(std::remove_if(result.phrases.begin(), result.phrases.end(),
+                                        [](const auto& phrase) { return phrase.size() < 2; }),
+                         result.phrases.end());
+    // Queries are a handful of words: sequential sort, parallel algorithms would allocate task state
     if (sort) {
-        std::sort(std::execution::par, result.minus_words.begin(), result.minus_words.end());
-        result.minus_words.erase(unique(std::execution::par, result.minus_words.begin(), result.minus_words.end()), result.minus_words.end());
-       std::sort(std::execution::par, result.plus_words.begin(), result.plus_words.end());
-        result.plus_words.erase(unique(std::execution::par, result.plus_words.begin(), result.plus_words.end()), result.plus_words.end());
+        std::sort(result.minus_words.begin(), result.minus_words.end());
+        result.minus_words.erase(unique(result.minus_words.begin(), result.minus_words.end()), result.minus_words.end());
+        std::sort(result.plus_words.begin(), result.plus_words.end());
+        result.plus_words.erase(unique(result.plus_words.begin(), result.plus_words.end()), result.plus_words.end());
+        std::sort(result.literal_plus_words.begin(), result.literal_plus_words.end());
+        result.literal_plus_words.erase(unique(result.literal_plus_words.begin(), result.literal_plus_words.end()),
+                                        result.literal_plus_words.end());
     }
     return result;
 }
 
+size_t SearchServer::CountPostings(const std::pmr::vector<std::string_view>& words) const {
+    size_t postings = 0;
+    for (const std::string_view word : words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it != word_to_document_freqs_.end()) {
+            postings += it->second.size();
+        }
+    }
+    return postings;
+}
+
+void SearchServer::ExpandWildcard(std::string_view pattern, std::pmr::vector<std::string_view>& words) const {
+    const std::string_view prefix = pattern.substr(0, pattern.find('*'));
+    if (prefix.size() < MIN_WILDCARD_PREFIX) {
+        throw std::invalid_argument("Wildcard needs a longer literal prefix"s);
+    }
+    const bool is_prefix_pattern = prefix.size() + 1 == pattern.size();
+    size_t expanded = 0;
+    size_t scanned = 0;
+    for (auto it = word_to_document_freqs_.lower_bound(prefix);
+         it != word_to_document_freqs_.end() && it->first.substr(0, prefix.size()) == prefix
+         && expanded < MAX_WILDCARD_EXPANSION && scanned < MAX_WILDCARD_SCAN;
+         ++it, ++scanned) {
+        if (!(is_prefix_pattern || MatchesWildcard(it->first, pattern))) {
+            continue;
+        }
+        words.push_back(it->first);
+        ++expanded;
+    }
+}
+
+void SearchServer::ApplyPositionalRanking(const Query& query, std::pmr::vector<Document>& matched_documents,
+                                          std::pmr::memory_resource* resource) const {
+    if (!positional_index_enabled_) {
+        return;
+    }
+    for (const auto& phrase : query.phrases) {
+        const auto phrase_documents = positional_index_.FindPhrase(phrase, resource);
+        auto phrase_it = phrase_documents.begin();
+        const auto last = std::remove_if(matched_documents.begin(), matched_documents.end(),
+                                         [&phrase_it, &phrase_documents](const Document& document) {
+                                             phrase_it = std::lower_bound(phrase_it, phrase_documents.end(), document.id);
+                                             return phrase_it == phrase_documents.end() || *phrase_it != document.id;
+                                         });
+        matched_documents.erase(last, matched_documents.end());
+    }
+    BoostProximity(query, matched_documents, resource);
+}
+
+void SearchServer::BoostProximity(const Query& query, std::pmr::vector<Document>& matched_documents,
+                                  std::pmr::memory_resource* resource) const {
+    if (!positional_index_enabled_ || query.literal_plus_words.size() < 2) {
+        return;
+    }
+    std::pmr::vector<int> document_ids(matched_documents.size(), 0, resource);
+    std::transform(matched_documents.begin(), matched_documents.end(), document_ids.begin(),
+                   [](const Document& document) { return document.id; });
+    const auto gaps = positional_index_.ComputeMinimalGaps(query.literal_plus_words, document_ids, resource);
+    for (size_t i = 0; i < matched_documents.size(); ++i) {
+        if (gaps[i] > 0) {
+            matched_documents[i].relevance *= 1.0 + PROXIMITY_WEIGHT / gaps[i];
+        }
+    }
+}
+
+bool SearchServer::ContainsPhrases(const Query& query, int document_id) const {
+    if (!positional_index_enabled_) {
+        return true;
+    }
+    std::pmr::memory_resource* resource = query.phrases.get_allocator().resource();
+    return std::all_of(query.phrases.begin(), query.phrases.end(), [this, document_id, resource](const auto& phrase) {
+        return positional_index_.ContainsPhrase(document_id, phrase, resource);
+    });
+}
+
 double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const {
     return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
 }
@@ -12,18 +12,37 @@
 #include <vector>
 #include <utility>
 #include <execution>
+#include <functional>
+#include <future>
 
 
 
 
 #include "string_processing.h"
 #include "document.h"
+#include "document_attributes.h"
 #include "concurrent_map.h"
+#include "positional_index.h"
+#include "query_arena.h"
+#include "query_trace.h"
+#include "ranked_results.h"
+#include "search_limits.h"
+#include "thread_pool.h"
 
 using namespace std::string_literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
-const double E = 1e-6;
+// Relevance multiplier for adjacent query words is 1 + PROXIMITY_WEIGHT, decaying with distance
+const double PROXIMITY_WEIGHT = 0.5;
+// Most dictionary words a single wildcard query word such as "cur*" expands to
+const size_t MAX_WILDCARD_EXPANSION = 64;
+// Wildcards need a literal prefix of at least this length: "*zz" or "c*" would scan most of the dictionary
+const size_t MIN_WILDCARD_PREFIX = 2;
+// Most dictionary entries inspected while expanding one wildcard, matching or not
+const size_t MAX_WILDCARD_SCAN = 4096;
+// A DocumentFilter is turned into a candidate mask, at the cost of a pass over all documents,
+// only when the query has at least this many postings per document; otherwise it is checked per posting
+const double FILTER_MASK_MIN_POSTINGS_SHARE = 0.25;
 
 class SearchServer {
 public:
@@ -33,6 +52,14 @@ public:
     explicit SearchServer(const std::string& stop_words_text);
     explicit SearchServer(const std::string_view stop_words_text);
 
+    // Makes the server keep word positions, enabling "quoted phrase" queries and proximity ranking.
+    // Must be called before documents are added.
+    void EnablePositionalIndex();
+
+    // Makes the server keep postings ordered by term frequency, which FindTopDocumentsLimited and
+    // FindTopDocumentsAsync traverse. Costs a tree node per posting. Must be called before documents are added.
+    void EnableImpactOrderedIndex();
+
     void AddDocument(int document_id,const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
     template <typename DocumentPredicate>
@@ -42,15 +69,68 @@ public:
 
     std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const;
 
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter) const;
+
     template <class ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query) const;
 
     template <class ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentStatus status) const;
 
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, const DocumentFilter& filter) const;
+
     template <class ExecutionPolicy, typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentPredicate document_predicate) const;
 
+    // Same search, traced when the tracer samples it
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate, QueryTracer& tracer) const;
+
+    template <class ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentPredicate document_predicate, QueryTracer& tracer) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, QueryTracer& tracer) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status, QueryTracer& tracer) const;
+
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, QueryTracer& tracer) const;
+
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentStatus status, QueryTracer& tracer) const;
+
+
+    // Unlike FindTopDocuments keeps every match, for paging deeper than MAX_RESULT_DOCUMENT_COUNT
+    template <typename DocumentPredicate>
+    RankedResults FindRankedDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    RankedResults FindRankedDocuments(const std::string_view raw_query) const;
+
+    RankedResults FindRankedDocuments(const std::string_view raw_query, DocumentStatus status) const;
+
+    RankedResults FindRankedDocuments(const std::string_view raw_query, const DocumentFilter& filter) const;
+
+    template <class ExecutionPolicy, typename DocumentPredicate>
+    RankedResults FindRankedDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    // Visits postings from the highest tf-idf impact down and stops once a limit is hit,
+    // returning the best documents found so far. Quoted phrases are checked only for the documents
+    // found, and the deadline and cancellation also apply to those checks.
+    // Requires EnableImpactOrderedIndex.
+    template <typename DocumentPredicate>
+    LimitedSearchResult FindTopDocumentsLimited(const std::string_view raw_query, DocumentPredicate document_predicate,
+                                                const SearchLimits& limits) const;
+
+    // FindTopDocumentsLimited as a task of the pool, whose workers keep their query arenas between tasks.
+    // The server must outlive the future and must not be modified until it is ready.
+    template <typename DocumentPredicate>
+    std::future<LimitedSearchResult> FindTopDocumentsAsync(std::string raw_query, DocumentPredicate document_predicate,
+                                                           SearchLimits limits,
+                                                           ThreadPool& pool = ThreadPool::GetShared()) const;
+
+    std::future<LimitedSearchResult> FindTopDocumentsAsync(std::string raw_query, SearchLimits limits,
+                                                           ThreadPool& pool = ThreadPool::GetShared()) const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
 
@@ -76,14 +156,27 @@ private:
     struct DocumentData {
         int rating;
         DocumentStatus status;
-        std::unordered_set<std::string> data_word;
     };
 
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
+    // Text of every indexed word; the string_view keys of the indexes below point here
+    std::set<std::string, std::less<>> words_;
+    struct Posting {
+        double term_freq = 0;
+        // Slot of the document in attributes_, so that filters need no id lookup
+        size_t slot = 0;
+    };
+
+    std::map<std::string_view, std::map<int, Posting>> word_to_document_freqs_;
+    bool impact_ordered_index_enabled_ = false;
+    // Same postings as (term frequency, document id), highest frequency first; kept only when enabled
+    std::map<std::string_view, std::set<std::pair<double, int>, std::greater<>>> word_to_impact_ordered_docs_;
     std::map<int, DocumentData> documents_;
+    DocumentAttributes attributes_;
     std::set<int> document_ids_;
     std::map<int, std::map<std::string_view, double, std::less<>>> document_to_word_freqs_;
+    bool positional_index_enabled_ = false;
+    PositionalIndex positional_index_;
 
     bool IsStopWord(const std::string_view word) const ;
 
@@ -91,34 +184,94 @@ private:
 
     std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
 
+    // Position of each word of SplitIntoWordsNoStop(text) among all words of text, stop words included
+    std::vector<uint32_t> ComputeWordPositions(std::string_view text) const;
+
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
     struct QueryWord {
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        bool is_wildcard;
     };
 
     QueryWord ParseQueryWord(std::string_view text) const;
 
     struct Query {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+        explicit Query(std::pmr::memory_resource* resource)
+                : plus_words(resource)
+                , literal_plus_words(resource)
+                , minus_words(resource)
+                , phrases(resource) {
+        }
+
+        std::pmr::vector<std::string_view> plus_words;
+        // Plus words written in the query, without wildcard expansions; used for proximity
+        std::pmr::vector<std::string_view> literal_plus_words;
+        std::pmr::vector<std::string_view> minus_words;
+        // Words of each quoted phrase, also present in plus_words. A stop word inside a phrase
+        // is kept as an empty word, so that the other words keep their distances
+        std::pmr::vector<std::pmr::vector<std::string_view>> phrases;
     };
 
-    Query ParseQuery(const std::string_view text, bool sort = false) const;
+    // Appends dictionary words matching the pattern in lexicographic order, at most MAX_WILDCARD_EXPANSION.
+    // The dictionary is ordered, so only the range sharing the literal prefix of the pattern is scanned,
+    // and at most MAX_WILDCARD_SCAN entries of it. Throws if the prefix is shorter than MIN_WILDCARD_PREFIX.
+    void ExpandWildcard(std::string_view pattern, std::pmr::vector<std::string_view>& words) const;
+
+    Query ParseQuery(const std::string_view text, bool sort = false,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
 
     // Existence required
     double ComputeWordInverseDocumentFreq(const std::string_view word) const ;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    std::pmr::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate,
+                                                std::pmr::memory_resource* resource) const;
 
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& , const Query& query, DocumentPredicate document_predicate) const;
+    template <class ExecutionPolicy, typename DocumentPredicate, typename Trace>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentPredicate document_predicate, Trace& trace) const;
+
+    size_t CountPostings(const std::pmr::vector<std::string_view>& words) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& , const Query& query, DocumentPredicate document_predicate) const;
+    bool MatchesPredicate(const DocumentPredicate& document_predicate, int document_id, size_t slot) const {
+        return document_predicate(document_id, attributes_.GetStatusAt(slot), attributes_.GetRatingAt(slot));
+    }
+
+    // Result of DocumentAttributes::Select, checked by slot alone
+    struct CandidateMask {
+        const std::pmr::vector<uint8_t>& candidates;
+    };
+
+    bool MatchesPredicate(const CandidateMask& mask, int, size_t slot) const {
+        return mask.candidates[slot] != 0;
+    }
+
+    template <class ExecutionPolicy, typename DocumentPredicate, typename Trace>
+    std::pmr::vector<Document> ScoreDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                              std::pmr::memory_resource* resource, Trace& trace) const;
+
+    // Drops documents missing a quoted phrase and boosts documents where query words are close.
+    // Does nothing without the positional index. matched_documents must be sorted by id.
+    void ApplyPositionalRanking(const Query& query, std::pmr::vector<Document>& matched_documents,
+                                std::pmr::memory_resource* resource) const;
+
+    // The proximity part of ApplyPositionalRanking
+    void BoostProximity(const Query& query, std::pmr::vector<Document>& matched_documents,
+                        std::pmr::memory_resource* resource) const;
+
+    // True if the document contains every quoted phrase of the query, or there is no positional index
+    bool ContainsPhrases(const Query& query, int document_id) const;
+
+    template <typename DocumentPredicate, typename Trace>
+    std::pmr::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& , const Query& query, DocumentPredicate document_predicate,
+                                                std::pmr::memory_resource* resource, Trace& trace) const;
+
+    template <typename DocumentPredicate, typename Trace>
+    std::pmr::vector<Document> FindAllDocuments(const std::execution::parallel_policy& , const Query& query, DocumentPredicate document_predicate,
+                                                std::pmr::memory_resource* resource, Trace& trace) const;
 };
 
 
@@ -146,12 +299,28 @@ void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
 
     std::for_each(policy, words.begin(), words.end(),
                   [&](const auto& word) {
-                      word_to_document_freqs_.at(word).erase(document_id);
+                      auto& document_freqs = word_to_document_freqs_.at(word);
+                      if (impact_ordered_index_enabled_) {
+                          word_to_impact_ordered_docs_.at(word).erase({document_freqs.at(document_id).term_freq, document_id});
+                      }
+                      document_freqs.erase(document_id);
                   }
     );
+    if (positional_index_enabled_) {
+        positional_index_.RemoveDocument(document_id, words);
+    }
+    for (const std::string_view word : words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it->second.empty()) {
+            word_to_impact_ordered_docs_.erase(word);
+            word_to_document_freqs_.erase(it);
+            words_.erase(words_.find(word));
+        }
+    }
 
     document_ids_.erase(document_id);
     documents_.erase(document_id);
+    attributes_.Remove(document_id);
     document_to_word_freqs_.erase(document_id);
 }
 
@@ -165,10 +334,13 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, c
 
 template <class ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status) const{
-    return FindTopDocuments(policy, raw_query,
-                            [status](int document_id, DocumentStatus document_status, int rating){
-                                return document_status == status;
-                            });
+    return FindTopDocuments(policy, raw_query, DocumentFilter(status));
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, const DocumentFilter& filter) const{
+    NoQueryTrace trace;
+    return FindTopDocuments(policy, raw_query, filter, trace);
 }
 
 template <typename DocumentPredicate>
@@ -178,96 +350,312 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
 
 template <class ExecutionPolicy, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentPredicate document_predicate) const{
-    const auto query = ParseQuery(raw_query, true);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-    std::sort(
-            policy,
-            matched_documents.begin(),
-            matched_documents.end(),
-            [](const Document& lhs, const Document& rhs) {
-                if (std::abs(lhs.relevance - rhs.relevance) < E) {
-                    return lhs.rating > rhs.rating;
-                } else {
-                    return lhs.relevance > rhs.relevance;
-                }
-            }
-    );
+    NoQueryTrace trace;
+    return FindTopDocuments(policy, raw_query, document_predicate, trace);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate, QueryTracer& tracer) const{
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, tracer);
+}
+
+template <class ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentPredicate document_predicate, QueryTracer& tracer) const{
+    if (!tracer.ShouldSample()) {
+        return FindTopDocuments(policy, raw_query, document_predicate);
+    }
+    QueryTrace trace(raw_query);
+    auto result = FindTopDocuments(policy, raw_query, document_predicate, trace);
+    tracer.Record(trace.Finish());
+    return result;
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, QueryTracer& tracer) const{
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL, tracer);
+}
+
+template <class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentStatus status, QueryTracer& tracer) const{
+    return FindTopDocuments(policy, raw_query, DocumentFilter(status), tracer);
+}
+
+template <class ExecutionPolicy, typename DocumentPredicate, typename Trace>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy,const std::string_view raw_query, DocumentPredicate document_predicate, Trace& trace) const{
+    // Scratch containers live in the thread's arena; only the returned top is heap-allocated
+    QueryArena::Scope arena_scope;
+    trace.Stage(QueryStage::PARSE);
+    const auto query = ParseQuery(raw_query, true, arena_scope.Resource());
+    auto matched_documents = ScoreDocuments(policy, query, document_predicate, arena_scope.Resource(), trace);
+    trace.Stage(QueryStage::POSITIONS);
+    ApplyPositionalRanking(query, matched_documents, arena_scope.Resource());
+    trace.Stage(QueryStage::SORT);
+    std::sort(policy, matched_documents.begin(), matched_documents.end(), IsRankedHigher);
     if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
         matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
     }
-    return matched_documents;
+    return {matched_documents.begin(), matched_documents.end()};
+}
+
+template <typename DocumentPredicate>
+RankedResults SearchServer::FindRankedDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const{
+    return FindRankedDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <class ExecutionPolicy, typename DocumentPredicate>
+RankedResults SearchServer::FindRankedDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const{
+    QueryArena::Scope arena_scope;
+    const auto query = ParseQuery(raw_query, true, arena_scope.Resource());
+    NoQueryTrace trace;
+    auto matched_documents = ScoreDocuments(policy, query, document_predicate, arena_scope.Resource(), trace);
+    ApplyPositionalRanking(query, matched_documents, arena_scope.Resource());
+    return RankedResults({matched_documents.begin(), matched_documents.end()});
+}
+
+template <class ExecutionPolicy, typename DocumentPredicate, typename Trace>
+std::pmr::vector<Document> SearchServer::ScoreDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                                        std::pmr::memory_resource* resource, Trace& trace) const{
+    if constexpr (std::is_same_v<DocumentPredicate, DocumentFilter>) {
+        if (CountPostings(query.plus_words) >= attributes_.GetSlotCount() * FILTER_MASK_MIN_POSTINGS_SHARE) {
+            trace.Stage(QueryStage::SELECT_CANDIDATES);
+            const auto candidates = attributes_.Select(document_predicate, resource);
+            return FindAllDocuments(policy, query, CandidateMask{candidates}, resource, trace);
+        }
+    }
+    return FindAllDocuments(policy, query, document_predicate, resource, trace);
+}
+
+template <typename DocumentPredicate>
+LimitedSearchResult SearchServer::FindTopDocumentsLimited(const std::string_view raw_query, DocumentPredicate document_predicate,
+                                                          const SearchLimits& limits) const{
+    // Deadline and cancellation are polled once per this many postings
+    const size_t check_period = 128;
+
+    if (!impact_ordered_index_enabled_) {
+        throw std::logic_error("Limited search requires the impact-ordered index"s);
+    }
+    QueryArena::Scope arena_scope;
+    std::pmr::memory_resource* resource = arena_scope.Resource();
+    const auto query = ParseQuery(raw_query, true, resource);
+
+    struct Cursor {
+        double impact;
+        double inverse_document_freq;
+        std::set<std::pair<double, int>, std::greater<>>::const_iterator it;
+        std::set<std::pair<double, int>, std::greater<>>::const_iterator end;
+    };
+    const auto by_impact = [](const Cursor& lhs, const Cursor& rhs) {
+        return lhs.impact < rhs.impact;
+    };
+    std::pmr::vector<Cursor> cursors(resource);
+    for (const std::string_view word : query.plus_words) {
+        const auto it = word_to_impact_ordered_docs_.find(word);
+        if (it == word_to_impact_ordered_docs_.end() || it->second.empty()) {
+            continue;
+        }
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+        cursors.push_back({it->second.begin()->first * inverse_document_freq, inverse_document_freq,
+                           it->second.begin(), it->second.end()});
+    }
+    std::make_heap(cursors.begin(), cursors.end(), by_impact);
+
+    const auto interrupted = [&limits]() {
+        return (limits.cancelled && limits.cancelled->load(std::memory_order_relaxed))
+               || std::chrono::steady_clock::now() >= limits.deadline;
+    };
+
+    LimitedSearchResult result;
+    std::pmr::map<int, double> document_to_relevance(resource);
+    while (!cursors.empty()) {
+        if (result.postings_visited >= limits.max_postings
+            || (result.postings_visited % check_period == 0 && interrupted())) {
+            result.is_partial = true;
+            break;
+        }
+        std::pop_heap(cursors.begin(), cursors.end(), by_impact);
+        Cursor& cursor = cursors.back();
+        const auto [term_freq, document_id] = *cursor.it;
+        ++result.postings_visited;
+        if (MatchesPredicate(document_predicate, document_id, attributes_.GetSlot(document_id))) {
+            document_to_relevance[document_id] += cursor.impact;
+        }
+        if (++cursor.it == cursor.end) {
+            cursors.pop_back();
+        } else {
+            cursor.impact = cursor.it->first * cursor.inverse_document_freq;
+            std::push_heap(cursors.begin(), cursors.end(), by_impact);
+        }
+    }
+
+    for (const std::string_view word : query.minus_words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it == word_to_document_freqs_.end()) {
+            continue;
+        }
+        for (auto doc_it = document_to_relevance.begin(); doc_it != document_to_relevance.end();) {
+            doc_it = it->second.count(doc_it->first) ? document_to_relevance.erase(doc_it) : std::next(doc_it);
+        }
+    }
+
+    std::pmr::vector<Document> matched_documents(resource);
+    matched_documents.reserve(document_to_relevance.size());
+    for (const auto [document_id, relevance] : document_to_relevance) {
+        matched_documents.push_back({document_id, relevance, attributes_.GetRating(document_id)});
+    }
+    if (positional_index_enabled_ && !query.phrases.empty()) {
+        // Phrases are checked per document found, so there is at most one check per visited posting.
+        // The best documents go first: a deadline or cancellation hit here drops only the unchecked rest.
+        const bool interruptible = limits.cancelled || limits.deadline != std::chrono::steady_clock::time_point::max();
+        if (interruptible) {
+            std::sort(matched_documents.begin(), matched_documents.end(), IsRankedHigher);
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < matched_documents.size(); ++i) {
+            if (interruptible && interrupted()) {
+                result.is_partial = true;
+                break;
+            }
+            if (ContainsPhrases(query, matched_documents[i].id)) {
+                matched_documents[kept++] = matched_documents[i];
+            }
+        }
+        matched_documents.erase(matched_documents.begin() + kept, matched_documents.end());
+        if (interruptible) {
+            std::sort(matched_documents.begin(), matched_documents.end(),
+                      [](const Document& lhs, const Document& rhs) { return lhs.id < rhs.id; });
+        }
+    }
+    BoostProximity(query, matched_documents, resource);
+    const size_t top_count = std::min(matched_documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + top_count, matched_documents.end(), IsRankedHigher);
+    result.documents.assign(matched_documents.begin(), matched_documents.begin() + top_count);
+    return result;
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const{
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+std::future<LimitedSearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, DocumentPredicate document_predicate,
+                                                                     SearchLimits limits, ThreadPool& pool) const{
+    // Fail here rather than through the future
+    if (!impact_ordered_index_enabled_) {
+        throw std::logic_error("Limited search requires the impact-ordered index"s);
+    }
+    return pool.Submit([this, raw_query = std::move(raw_query), document_predicate, limits = std::move(limits)]() {
+        return FindTopDocumentsLimited(raw_query, document_predicate, limits);
+    });
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy& , const Query& query, DocumentPredicate document_predicate) const{
-    std::map<int, double> document_to_relevance;
+std::pmr::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate,
+                                                          std::pmr::memory_resource* resource) const{
+    NoQueryTrace trace;
+    return FindAllDocuments(std::execution::seq, query, document_predicate, resource, trace);
+}
+
+template <typename DocumentPredicate, typename Trace>
+std::pmr::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy& , const Query& query, DocumentPredicate document_predicate,
+                                                          std::pmr::memory_resource* resource, Trace& trace) const{
+    trace.Stage(QueryStage::TRAVERSE);
+    std::pmr::map<int, double> document_to_relevance(resource);
     for (std::string_view word : query.plus_words){
         if (word_to_document_freqs_.count(word) == 0){
             continue;
         }
         const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)){
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)){
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        const auto& postings = word_to_document_freqs_.at(word);
+        size_t postings_scored = 0;
+        for (const auto& [document_id, posting] : postings){
+            if (MatchesPredicate(document_predicate, document_id, posting.slot)){
+                document_to_relevance[document_id] += posting.term_freq * inverse_document_freq;
+                if constexpr (Trace::enabled) {
+                    ++postings_scored;
+                }
             }
         }
+        if constexpr (Trace::enabled) {
+            trace.Count(postings.size(), 0, postings.size() - postings_scored);
+        }
     }
+    if constexpr (Trace::enabled) {
+        trace.Count(0, document_to_relevance.size(), 0);
+    }
+    trace.Stage(QueryStage::MINUS_WORDS);
     for (std::string_view word : query.minus_words){
         if (word_to_document_freqs_.count(word) == 0){
             continue;
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)){
+        const auto& postings = word_to_document_freqs_.at(word);
+        for (const auto [document_id, _] : postings){
             document_to_relevance.erase(document_id);
         }
+        if constexpr (Trace::enabled) {
+            trace.Count(postings.size(), 0, 0);
+        }
     }
 
-    std::vector<Document> matched_documents;
+    trace.Stage(QueryStage::MERGE);
+    std::pmr::vector<Document> matched_documents(resource);
+    matched_documents.reserve(document_to_relevance.size());
     for (const auto [document_id, relevance] : document_to_relevance)
     {
         matched_documents.push_back(
-                {document_id, relevance, documents_.at(document_id).rating});
+                {document_id, relevance, attributes_.GetRating(document_id)});
     }
     return matched_documents;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query &query, DocumentPredicate document_predicate) const{
+template <typename DocumentPredicate, typename Trace>
+std::pmr::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query &query, DocumentPredicate document_predicate,
+                                                          std::pmr::memory_resource* resource, Trace& trace) const{
 
-    ConcurrentMap<int, double> document_to_relevance(101);
+    trace.Stage(QueryStage::TRAVERSE);
+    // Every matched document is one of the postings, so their count bounds the map size
+    ConcurrentMap<int, double> document_to_relevance(101, resource,
+                                                     std::min(CountPostings(query.plus_words), documents_.size()));
 
-    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), [this, &document_predicate, &document_to_relevance](std::string_view word){
+    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), [this, &document_predicate, &document_to_relevance, &trace](std::string_view word){
         if ( word_to_document_freqs_.count(word) == 0 ) {
             return ;
         }
             const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for ( const auto& [document_id, term_freq] : word_to_document_freqs_.at(word) ) {
-                const auto &document_data = documents_.at(document_id);
-                if ( document_predicate(document_id, document_data.status, document_data.rating) ) {
-                    document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-
+            const auto& postings = word_to_document_freqs_.at(word);
+            size_t postings_scored = 0;
+            for ( const auto& [document_id, posting] : postings ) {
+                if ( MatchesPredicate(document_predicate, document_id, posting.slot) ) {
+                    document_to_relevance[document_id].ref_to_value += posting.term_freq * inverse_document_freq;
+                    if constexpr (Trace::enabled) {
+                        ++postings_scored;
+                    }
                 }
             }
+            if constexpr (Trace::enabled) {
+                trace.Count(postings.size(), 0, postings.size() - postings_scored);
+            }
     }
     );
-    std::map<int, double> document_to_relevance2(document_to_relevance.BuildOrdinaryMap());
-    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(), [this, &document_predicate, &document_to_relevance2](std::string_view word){
+    trace.Stage(QueryStage::BUILD_MAP);
+    std::pmr::map<int, double> document_to_relevance2(document_to_relevance.BuildOrdinaryMap());
+    if constexpr (Trace::enabled) {
+        trace.Count(0, document_to_relevance2.size(), 0);
+    }
+    trace.Stage(QueryStage::MINUS_WORDS);
+    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(), [this, &document_predicate, &document_to_relevance2, &trace](std::string_view word){
         if ( word_to_document_freqs_.count(word) != 0 ) {
-            for ( const auto [document_id, _] :  word_to_document_freqs_.at(word) ) {
+            const auto& postings = word_to_document_freqs_.at(word);
+            for ( const auto [document_id, _] :  postings ) {
                 document_to_relevance2.erase(document_id);
             }
+            if constexpr (Trace::enabled) {
+                trace.Count(postings.size(), 0, 0);
+            }
         }
     });
 
-    std::vector<Document> matched_documents;
+    trace.Stage(QueryStage::MERGE);
+    std::pmr::vector<Document> matched_documents(resource);
+    matched_documents.reserve(document_to_relevance2.size());
     for (const auto [document_id, relevance] : document_to_relevance2)
     {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+        matched_documents.push_back({document_id, relevance, attributes_.GetRating(document_id)});
     }
     return matched_documents;
 }
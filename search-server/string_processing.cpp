@@ -1,9 +1,7 @@
 #include "string_processing.h"
 
-
-
-std::vector<std::string_view> SplitIntoWords(std::string_view text) {
-    std::vector<std::string_view> result;
+template <typename Container>
+static void SplitIntoWordsTo(std::string_view text, Container& result) {
     while (true) {
         auto pos_space = text.find(' ');
         result.push_back(text.substr(0, pos_space));
@@ -13,5 +11,42 @@ std::vector<std::string_view> SplitIntoWords(std::string_view text) {
             text.remove_prefix(pos_space + 1);
         }
     }
+}
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> result;
+    SplitIntoWordsTo(text, result);
     return result;
 }
+
+std::pmr::vector<std::string_view> SplitIntoWords(std::string_view text, std::pmr::memory_resource* resource) {
+    std::pmr::vector<std::string_view> result(resource);
+    SplitIntoWordsTo(text, result);
+    return result;
+}
+
+bool MatchesWildcard(std::string_view word, std::string_view pattern) {
+    size_t word_pos = 0;
+    size_t pattern_pos = 0;
+    // Position after the last '*' seen and the word position it is currently matched up to
+    size_t star_pos = pattern.npos;
+    size_t star_word_pos = 0;
+    while (word_pos < word.size()) {
+        if (pattern_pos < pattern.size() && pattern[pattern_pos] == '*') {
+            star_pos = ++pattern_pos;
+            star_word_pos = word_pos;
+        } else if (pattern_pos < pattern.size() && pattern[pattern_pos] == word[word_pos]) {
+            ++pattern_pos;
+            ++word_pos;
+        } else if (star_pos != pattern.npos) {
+            pattern_pos = star_pos;
+            word_pos = ++star_word_pos;
+        } else {
+            return false;
+        }
+    }
+    while (pattern_pos < pattern.size() && pattern[pattern_pos] == '*') {
+        ++pattern_pos;
+    }
+    return pattern_pos == pattern.size();
+}
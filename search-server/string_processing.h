@@ -2,11 +2,17 @@
 #include <string>
 #include <vector>
 
+#include <memory_resource>
 #include <set>
 #include <string_view>
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+std::pmr::vector<std::string_view> SplitIntoWords(std::string_view text, std::pmr::memory_resource* resource);
+
+// '*' in pattern matches any sequence of characters, possibly empty
+bool MatchesWildcard(std::string_view word, std::string_view pattern);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
@@ -0,0 +1,141 @@
+// Checks that steady-state queries take their scratch memory from the per-thread QueryArena:
+// the only global heap allocation left is the returned result vector.
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+std::atomic<size_t> allocation_count{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    ++allocation_count;
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+// Queries are passed as plain literals: a std::string longer than its inline buffer would allocate itself
+template <typename Query>
+bool CheckAllocations(const std::string& name, Query query) {
+    // Long enough for the arena to finish growing or shrinking to this query's needs
+    const int warm_up_runs = 8 * QueryArena::SHRINK_AFTER_QUERIES;
+    const int measured_runs = 100;
+    for (int i = 0; i < warm_up_runs; ++i) {
+        query();
+    }
+    for (int i = 0; i < measured_runs; ++i) {
+        const size_t before = allocation_count.load();
+        const std::vector<Document> result = query();
+        const size_t allocations = allocation_count.load() - before;
+        // The returned vector is the only allocation, and an empty one allocates nothing
+        const size_t expected = result.empty() ? 0 : 1;
+        if (allocations != expected) {
+            std::cerr << name << ": "s << allocations << " allocations, expected "s << expected << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    SearchServer search_server("and with"s);
+    const std::vector<std::string> texts = {
+            "funny pet and nasty rat"s,
+            "funny pet with curly hair"s,
+            "nasty rat with curly tail"s,
+            "big dog and small cat"s,
+    };
+    for (int document_id = 0; document_id < 2000; ++document_id) {
+        const DocumentStatus status = document_id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(document_id, texts[document_id % texts.size()], status, {document_id % 10});
+    }
+
+    bool ok = true;
+    ok &= CheckAllocations("plain query"s, [&] {
+        return search_server.FindTopDocuments("curly nasty -tail");
+    });
+    ok &= CheckAllocations("empty result"s, [&] {
+        return search_server.FindTopDocuments("parrot");
+    });
+    ok &= CheckAllocations("status"s, [&] {
+        return search_server.FindTopDocuments("funny cat", DocumentStatus::BANNED);
+    });
+    ok &= CheckAllocations("filter"s, [&] {
+        return search_server.FindTopDocuments("pet rat dog", DocumentFilter().WithRating(2, 5).WithIds(100, 900));
+    });
+    ok &= CheckAllocations("predicate"s, [&] {
+        return search_server.FindTopDocuments("curly dog", [](int document_id, DocumentStatus, int) {
+            return document_id % 2 == 0;
+        });
+    });
+    ok &= CheckAllocations("wildcard"s, [&] {
+        return search_server.FindTopDocuments("cu* -ta*");
+    });
+
+    if (!ok) {
+        return 1;
+    }
+    std::cout << "OK"s << std::endl;
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads fed from one task queue. Workers live as long as the pool,
+// so their per-thread state, such as the QueryArena buffer, is reused from task to task.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+    // Finishes the queued tasks, then joins the workers
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> Submit(Function function);
+
+    size_t GetThreadCount() const {
+        return threads_.size();
+    }
+
+    // One worker per hardware thread, created on first use
+    static ThreadPool& GetShared();
+
+private:
+    void Work();
+
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+template <typename Function>
+std::future<std::invoke_result_t<Function>> ThreadPool::Submit(Function function) {
+    // std::function needs a copyable target, packaged_task is move-only
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    auto result = task->get_future();
+    {
+        std::lock_guard guard(mutex_);
+        tasks_.emplace_back([task]() {
+            (*task)();
+        });
+    }
+    task_available_.notify_one();
+    return result;
+}